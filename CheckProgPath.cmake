@@ -69,7 +69,9 @@ function(CHECK_PROG_PATH)
   check_include_file("fcntl.h" HAVE_FCNTL_H)
   check_include_file("mach-o/dyld.h" HAVE_MACH_O_DYLD_H)
   check_include_file("procinfo.h" HAVE_PROCINFO_H)
+  check_include_file("pthread.h" HAVE_PTHREAD_H)
   check_include_file("sys/auxv.h" HAVE_SYS_AUXV_H)
+  check_include_file("sys/inotify.h" HAVE_SYS_INOTIFY_H)
   check_include_file("sys/ioctl.h" HAVE_SYS_IOCTL_H)
   check_include_file("sys/param.h" HAVE_SYS_PARAM_H)
   check_include_file("sys/procfs.h" HAVE_SYS_PROCFS_H)
@@ -77,6 +79,7 @@ function(CHECK_PROG_PATH)
   check_include_file("sys/types.h" HAVE_SYS_TYPES_H)
   check_include_file("sys/wait.h" HAVE_SYS_WAIT_H)
   check_include_file("libproc.h" HAVE_LIBPROC_H)
+  check_include_file("link.h" HAVE_LINK_H)
   check_include_file("unistd.h" HAVE_UNISTD_H)
   check_include_file("windows.h" HAVE_WINDOWS_H)
   check_include_file("io.h" HAVE_IO_H)
@@ -119,13 +122,19 @@ function(CHECK_PROG_PATH)
   check_symbol_exists(_getcwd "direct.h" HAVE__GETCWD)
   check_function_exists(dladdr HAVE_DLADDR)
   check_function_exists(dlsym HAVE_DLSYM)
+  check_function_exists(dl_iterate_phdr HAVE_DL_ITERATE_PHDR)
   check_function_exists(find_path HAVE_FIND_PATH)
+  check_function_exists(fstatat HAVE_FSTATAT)
   check_function_exists(getauxval HAVE_GETAUXVAL)
   check_function_exists(getcwd HAVE_GETCWD)
   check_function_exists(getexecname HAVE_GETEXECNAME)
   check_function_exists(getprocs HAVE_GETPROCS)
   check_function_exists(getprocs64 HAVE_GETPROCS64)
   check_function_exists(getprogname HAVE_GETPROGNAME)
+  check_function_exists(inotify_init1 HAVE_INOTIFY_INIT1)
+  check_function_exists(lstat HAVE_LSTAT)
+  check_function_exists(nanosleep HAVE_NANOSLEEP)
+  check_function_exists(openat HAVE_OPENAT)
   check_function_exists(proc_pidpath HAVE_PROC_PIDPATH)
   check_function_exists(read HAVE_READ)
   check_function_exists(readlink HAVE_READLINK)
@@ -146,12 +155,25 @@ function(CHECK_PROG_PATH)
   # procfs structures
   check_struct_has_member("struct psinfo" pr_argv sys/procfs.h HAVE_STRUCT_PSINFO)
   check_struct_has_member("struct prpsinfo" pr_fname sys/procfs.h HAVE_STRUCT_PRPSINFO)
+
+  # file identity, used for change detection
+  check_struct_has_member("struct stat" st_mtim sys/stat.h HAVE_STRUCT_STAT_ST_MTIM)
   
   # C constructor attributes/pragmas for auto initialization
   check_c_source_compiles(
     "static void init(void) {}\n__attribute__((constructor)) static void my_init(void) { init(); }\nint main(void) { return 0; }"
     HAVE_ATTRIBUTE_CONSTRUCTOR
   )
+  # glibc's loader hands (argc, argv, envp) to .init_array functions
+  check_c_source_compiles(
+    "#include <stdlib.h>\n#ifndef __GLIBC__\n#error constructor arguments unspecified\n#endif\n__attribute__((constructor)) static void my_init(int ac, char **av, char **ev) { (void)ac; (void)av; (void)ev; }\nint main(void) { return 0; }"
+    HAVE_INIT_ARRAY_ARGS
+  )
+  # weak, exported data for sharing state between copies of the implementation
+  check_c_source_compiles(
+    "__attribute__((weak, visibility(\"default\"))) int *shared_ptr = 0;\nint main(void) { return shared_ptr != 0; }"
+    HAVE_ATTRIBUTE_WEAK
+  )
   check_c_source_compiles(
     "#pragma section(\".CRT$XCU\",read)\nstatic void init(void) {}\n__declspec(allocate(\".CRT$XCU\")) void (* const init_ptr)(void) = init;\nint main(void) { return 0; }"
     HAVE_PRAGMA_SECTION
@@ -0,0 +1,118 @@
+/*                  B E N C H _ B A K E D . C
+ * progpath
+ *
+ * Cost per progpath() call with a baked executable path against the
+ * dynamic method chain, as the process state gets harder to resolve:
+ * as launched, after a chdir() deep into a tree, and when argv[0] is a
+ * bare name found at the end of a long PATH.  Built once per policy;
+ * the dynamic chain is measured by turning the baked path off at run
+ * time.
+ *
+ * Usage: bench_baked [ITERATIONS]
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+
+static const char *baked_path = "";
+#define PROGPATH_BAKED_PATH baked_path
+
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define DEFAULT_ITERATIONS 20000
+#define TREE "bench_baked_tree"
+#define DEPTH 32
+#define PATH_DIRS 1000
+
+#if PROGPATH_BAKED_POLICY == PROGPATH_BAKED_TRUST
+#  define POLICY "trust"
+#elif PROGPATH_BAKED_POLICY == PROGPATH_BAKED_VERIFY
+#  define POLICY "verify"
+#else
+#  define POLICY "fallback"
+#endif
+
+static long now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+static double ns_per_call(const char *path, int iterations) {
+  char buf[MAXPATHLEN];
+  long start;
+  int i;
+
+  baked_path = path;
+  pp_state()->exe[0] = '\0';
+#if PROGPATH_BAKED_POLICY != PROGPATH_BAKED_TRUST
+  progpath_baked = 0;
+#endif
+  start = now_us();
+  for (i = 0; i < iterations; i++)
+    progpath(buf, sizeof(buf));
+  return (double)(now_us() - start) * 1000.0 / iterations;
+}
+
+static void row(const char *state, const char *self, int iterations) {
+  double dynamic = ns_per_call("", iterations / 10);
+  double baked = ns_per_call(self, iterations);
+  printf("%-34s %12.0f ns %12.1f ns\n", state, dynamic, baked);
+}
+
+int main(int ac, char *av[]) {
+  char self[MAXPATHLEN] = {0};
+  char dir[MAXPATHLEN] = TREE;
+  char *path;
+  char *base;
+  int iterations = DEFAULT_ITERATIONS;
+  int i;
+
+  if (ac > 1 && atoi(av[1]) > 0)
+    iterations = atoi(av[1]);
+  if (!progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+
+  printf("policy %s, per progpath() call  %12s %15s\n", POLICY, "dynamic", "baked");
+  row("as launched", self, iterations);
+
+  mkdir(TREE, 0777);
+  for (i = 1; i < DEPTH; i++) {
+    snprintf(dir + strlen(dir), sizeof(dir) - strlen(dir), "/d%d", i);
+    mkdir(dir, 0777);
+  }
+  if (chdir(dir) == 0)
+    row("after chdir() 32 levels deep", self, iterations);
+
+  /* bare argv[0] found in the last of many PATH directories */
+  path = (char *)malloc(PATH_DIRS * 32 + MAXPATHLEN);
+  path[0] = '\0';
+  for (i = 0; i < PATH_DIRS; i++)
+    sprintf(path + strlen(path), "/nonexistent/bin%d:", i);
+  strcat(path, self);
+  base = strrchr(path, '/');
+  *base++ = '\0';
+  pp_state()->have_args = 1;
+  pp_state()->argv0 = base;
+  pp_state()->env_path = path;
+  row("bare argv[0], 1000-entry PATH", self, iterations);
+
+  if (progipwd(self, sizeof(self)) && chdir(self) == 0) {
+    while (strcmp(dir, TREE) != 0) {
+      rmdir(dir);
+      *strrchr(dir, '/') = '\0';
+    }
+    rmdir(TREE);
+  }
+  free(path);
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*                  B E N C H _ C A N O N . C
+ * progpath
+ *
+ * Throughput of canonicalizing many paths under the same deep
+ * directories, as module and resource lookups do: realpath() per path
+ * against progpath_canon(), which resolves each directory once and
+ * then only looks at the new components.  The tree is entered through
+ * a symlink so both have a link to follow.  Also times progpath_canon()
+ * when the cache is emptied before every path.
+ *
+ * Usage: bench_canon [COUNT]
+ */
+
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define DEFAULT_COUNT 100000
+#define TREE "bench_canon_tree"
+#define DEPTH 16
+#define FILES 100
+
+static long now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+static void report(const char *label, long us, size_t count) {
+  printf("%-32s %8.1f ms  %10.0f paths/s\n", label, us / 1000.0, us > 0 ? count * 1e6 / us : 0.0);
+}
+
+int main(int ac, char *av[]) {
+  char dir[4096] = TREE "/real";
+  char linked[4096] = TREE "/link";
+  char root[4096] = {0};
+  char **in;
+  char *expected;
+  size_t count = DEFAULT_COUNT;
+  size_t i;
+  long start;
+  int mismatches = 0;
+
+  if (ac > 1 && atol(av[1]) > 0)
+    count = (size_t)atol(av[1]);
+
+  mkdir(TREE, 0777);
+  mkdir(dir, 0777);
+  for (i = 1; i < DEPTH; i++) {
+    snprintf(dir + strlen(dir), sizeof(dir) - strlen(dir), "/d%lu", (unsigned long)i);
+    snprintf(linked + strlen(linked), sizeof(linked) - strlen(linked), "/d%lu", (unsigned long)i);
+    mkdir(dir, 0777);
+  }
+  if (symlink("real", TREE "/link") != 0 || !realpath(TREE, root)) {
+    fprintf(stderr, "FAIL: could not create %s\n", TREE);
+    return 1;
+  }
+
+  /* absolute, so both sides skip the working directory */
+  in = (char **)calloc(count, sizeof(char *));
+  for (i = 0; i < count; i++) {
+    char file[8192 + 32];
+    snprintf(file, sizeof(file), "%s/%s/f%lu", root, linked + strlen(TREE) + 1, (unsigned long)(i % FILES));
+    if (i < FILES) {
+      char real[4096 + 32];
+      FILE *fp;
+      snprintf(real, sizeof(real), "%s/f%lu", dir, (unsigned long)i);
+      fp = fopen(real, "w");
+      if (fp)
+        fclose(fp);
+    }
+    in[i] = strdup(file);
+  }
+  expected = (char *)calloc(count, 4096);
+
+  printf("%lu paths, %d directories deep\n", (unsigned long)count, DEPTH);
+
+  start = now_us();
+  for (i = 0; i < count; i++) {
+    if (!realpath(in[i], expected + i * 4096))
+      expected[i * 4096] = '\0';
+  }
+  report("realpath", now_us() - start, count);
+
+  start = now_us();
+  for (i = 0; i < count; i++) {
+    char out[4096] = {0};
+    if (!progpath_canon(in[i], out, sizeof(out)))
+      out[0] = '\0';
+    if (strcmp(out, expected + i * 4096) != 0)
+      mismatches++;
+  }
+  report("progpath_canon", now_us() - start, count);
+
+  start = now_us();
+  for (i = 0; i < count; i++) {
+    char out[4096];
+    progpath_canon_invalidate(NULL);
+    progpath_canon(in[i], out, sizeof(out));
+  }
+  report("  ... invalidated every path", now_us() - start, count);
+
+  for (i = 0; i < FILES; i++) {
+    char real[4096 + 32];
+    snprintf(real, sizeof(real), "%s/f%lu", dir, (unsigned long)i);
+    unlink(real);
+  }
+  while (strcmp(dir, TREE) != 0) {
+    rmdir(dir);
+    *strrchr(dir, '/') = '\0';
+  }
+  unlink(TREE "/link");
+  rmdir(TREE);
+  for (i = 0; i < count; i++)
+    free(in[i]);
+  free(in);
+  free(expected);
+
+  if (mismatches) {
+    fprintf(stderr, "FAIL: %d results differ from realpath()\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*               B E N C H _ F R O M _ I P W D . C
+ * progpath
+ *
+ * Throughput of turning relative input paths into absolute ones after
+ * a chdir(): by hand with progipwd(), a concatenation, and realpath()
+ * per path, against progpath_from_ipwd_batch() with and without
+ * canonicalization.  Paths point into a small tree several directories
+ * deep, as build manifests tend to.
+ *
+ * Usage: bench_from_ipwd [COUNT]
+ */
+
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define DEFAULT_COUNT 100000
+#define TREE "bench_ipwd_tree"
+#define DEPTH 6
+#define FILES 100
+
+static long now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+static void report(const char *label, long us, size_t count) {
+  printf("%-32s %8.1f ms  %10.0f paths/s\n", label, us / 1000.0, us > 0 ? count * 1e6 / us : 0.0);
+}
+
+int main(int ac, char *av[]) {
+  char dir[4096] = TREE;
+  char ipwd[4096] = {0};
+  char **in;
+  char *out;
+  char *manual;
+  size_t *offs;
+  size_t count = DEFAULT_COUNT;
+  size_t outlen;
+  size_t i;
+  long start;
+  int mismatches = 0;
+
+  if (ac > 1 && atol(av[1]) > 0)
+    count = (size_t)atol(av[1]);
+
+  if (!progipwd(ipwd, sizeof(ipwd)) || !ipwd[0]) {
+    fprintf(stderr, "FAIL: progipwd() returned empty path\n");
+    return 1;
+  }
+
+  mkdir(TREE, 0777);
+  for (i = 1; i < DEPTH; i++) {
+    snprintf(dir + strlen(dir), sizeof(dir) - strlen(dir), "/d%lu", (unsigned long)i);
+    mkdir(dir, 0777);
+  }
+  in = (char **)calloc(count, sizeof(char *));
+  for (i = 0; i < count; i++) {
+    char file[4096 + 32];
+    snprintf(file, sizeof(file), "%s/f%lu", dir, (unsigned long)(i % FILES));
+    if (i < FILES) {
+      FILE *fp = fopen(file, "w");
+      if (fp)
+        fclose(fp);
+    }
+    in[i] = strdup(file);
+  }
+
+  outlen = count * (strlen(ipwd) + strlen(dir) + 16);
+  out = (char *)malloc(outlen);
+  manual = (char *)malloc(outlen);
+  offs = (size_t *)calloc(count, sizeof(size_t));
+
+  if (chdir("/") != 0) {
+    fprintf(stderr, "FAIL: chdir(/) failed\n");
+    return 1;
+  }
+
+  printf("%lu paths, %d directories deep\n", (unsigned long)count, DEPTH);
+
+  start = now_us();
+  {
+    char *p = manual;
+    for (i = 0; i < count; i++) {
+      char joined[8192];
+      char root[4096];
+      progipwd(root, sizeof(root));
+      snprintf(joined, sizeof(joined), "%s/%s", root, in[i]);
+      if (!realpath(joined, p))
+        p[0] = '\0';
+      p += strlen(p) + 1;
+    }
+  }
+  report("progipwd + concat + realpath", now_us() - start, count);
+
+  start = now_us();
+  if (progpath_from_ipwd_batch((const char **)in, count, out, outlen, offs, 0) != count) {
+    fprintf(stderr, "FAIL: batch output did not fit\n");
+    return 1;
+  }
+  report("progpath_from_ipwd_batch", now_us() - start, count);
+
+  {
+    const char *p = manual;
+    for (i = 0; i < count; i++) {
+      if (strcmp(p, out + offs[i]) != 0)
+        mismatches++;
+      p += strlen(p) + 1;
+    }
+  }
+
+  start = now_us();
+  progpath_from_ipwd_batch((const char **)in, count, out, outlen, offs, PROGPATH_BATCH_NO_CANON);
+  report("  ... PROGPATH_BATCH_NO_CANON", now_us() - start, count);
+
+  start = now_us();
+  progpath_from_ipwd_batch((const char **)in, count, out, outlen, offs, PROGPATH_BATCH_NO_CANON | PROGPATH_BATCH_MUST_EXIST);
+  report("  ... and MUST_EXIST", now_us() - start, count);
+
+  if (chdir(ipwd) == 0) {
+    for (i = 0; i < FILES; i++)
+      unlink(in[i]);
+    while (strcmp(dir, TREE) != 0) {
+      rmdir(dir);
+      *strrchr(dir, '/') = '\0';
+    }
+    rmdir(TREE);
+  }
+  for (i = 0; i < count; i++)
+    free(in[i]);
+  free(in);
+  free(out);
+  free(manual);
+  free(offs);
+
+  if (mismatches) {
+    fprintf(stderr, "FAIL: %d batch results differ from realpath()\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*                  B E N C H _ W H I C H . C
+ * progpath
+ *
+ * Compares resolving many command names by spawning 'which' once per
+ * name against a single 'progpath --stdin' process.  Names are taken
+ * from the directories on PATH, with every tenth one replaced by a
+ * name that does not exist so misses are measured too.
+ *
+ * Usage: bench_which PROGPATH_BIN [COUNT]
+ */
+
+#include "progpath.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_COUNT 1000
+
+static long now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+/* fill 'names' with up to 'count' entries found in the PATH directories */
+static int collect_names(char **names, int count) {
+  const char *path = getenv("PATH");
+  char *dirs;
+  char *dir;
+  int n = 0;
+
+  if (!path)
+    return 0;
+  dirs = strdup(path);
+  for (dir = strtok(dirs, ":"); dir && n < count; dir = strtok(NULL, ":")) {
+    DIR *d = opendir(dir);
+    struct dirent *ent;
+    if (!d)
+      continue;
+    while ((ent = readdir(d)) != NULL && n < count) {
+      if (ent->d_name[0] == '.')
+        continue;
+      names[n++] = strdup(ent->d_name);
+    }
+    closedir(d);
+  }
+  free(dirs);
+  return n;
+}
+
+/* run 'argv' with stdin from 'in' (or /dev/null) and output discarded */
+static int run(char *const argv[], const char *in) {
+  int status = 0;
+  pid_t pid = fork();
+
+  if (pid < 0)
+    return -1;
+  if (pid == 0) {
+    int fd_in = open(in ? in : "/dev/null", O_RDONLY);
+    int fd_out = open("/dev/null", O_WRONLY);
+    dup2(fd_in, STDIN_FILENO);
+    dup2(fd_out, STDOUT_FILENO);
+    dup2(fd_out, STDERR_FILENO);
+    execvp(argv[0], argv);
+    _exit(127);
+  }
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+    return -1;
+  return WEXITSTATUS(status);
+}
+
+int main(int ac, char *av[]) {
+  char list[] = "/tmp/bench_which.XXXXXX";
+  char **names;
+  int count = DEFAULT_COUNT;
+  int found;
+  int i;
+  long start;
+  long spawn_us;
+  long batch_us;
+  FILE *fp;
+  int fd;
+
+  if (ac < 2) {
+    fprintf(stderr, "Usage: %s PROGPATH_BIN [COUNT]\n", av[0]);
+    return 1;
+  }
+  if (ac > 2)
+    count = atoi(av[2]);
+  if (count < 1)
+    count = DEFAULT_COUNT;
+
+  names = (char **)calloc((size_t)count, sizeof(char *));
+  found = collect_names(names, count);
+  if (found == 0) {
+    printf("SKIP: no executables found on PATH\n");
+    return 0;
+  }
+  for (i = found; i < count; i++)
+    names[i] = strdup(names[i % found]);
+  for (i = 9; i < count; i += 10) {
+    char missing[64];
+    snprintf(missing, sizeof(missing), "progpath-bench-missing-%d", i);
+    free(names[i]);
+    names[i] = strdup(missing);
+  }
+
+  {
+    char *argv[] = {(char *)"which", (char *)"sh", NULL};
+    if (run(argv, NULL) == 127) {
+      printf("SKIP: 'which' is not available\n");
+      return 0;
+    }
+  }
+
+  fd = mkstemp(list);
+  fp = fd < 0 ? NULL : fdopen(fd, "w");
+  if (!fp) {
+    fprintf(stderr, "FAIL: could not create %s\n", list);
+    return 1;
+  }
+  for (i = 0; i < count; i++)
+    fprintf(fp, "%s\n", names[i]);
+  fclose(fp);
+
+  start = now_us();
+  for (i = 0; i < count; i++) {
+    char *argv[] = {(char *)"which", names[i], NULL};
+    run(argv, NULL);
+  }
+  spawn_us = now_us() - start;
+
+  start = now_us();
+  {
+    char *argv[] = {av[1], (char *)"--stdin", NULL};
+    if (run(argv, list) < 0) {
+      fprintf(stderr, "FAIL: %s --stdin did not run\n", av[1]);
+      unlink(list);
+      return 1;
+    }
+  }
+  batch_us = now_us() - start;
+  unlink(list);
+
+  printf("names resolved:          %d (%d unique, %d missing)\n", count, found, count / 10);
+  printf("which, one per name:     %8.1f ms  %8.2f us/name\n", spawn_us / 1000.0, (double)spawn_us / count);
+  printf("progpath --stdin, once:  %8.1f ms  %8.2f us/name\n", batch_us / 1000.0, (double)batch_us / count);
+  printf("speedup:                 %8.1fx\n", batch_us > 0 ? (double)spawn_us / batch_us : 0.0);
+
+  for (i = 0; i < count; i++)
+    free(names[i]);
+  free(names);
+  return 0;
+}
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #  include <direct.h>
@@ -11,14 +12,146 @@
 #  include <unistd.h>
 #endif
 
+static void usage(const char *name) {
+  printf("Usage: %s\n"
+         "       %s [--root DIR] [--canon] [-0] --which NAME...\n"
+         "       %s [--root DIR] [--canon] [-0] --stdin\n"
+         "\n"
+         "  --which NAME...  resolve each NAME like 'command -v', or a relative path\n"
+         "                   against the root, and print one record per NAME\n"
+         "  --stdin          same, reading NAMEs from standard input one per line\n"
+         "  --root DIR       resolve relative paths against DIR, itself relative to\n"
+         "                   the initial dir (default: initial dir)\n"
+         "  --canon          print canonical paths, with symlinks resolved\n"
+         "  -0               NUL-delimit records (and --stdin input) instead of newlines\n"
+         "\n"
+         "Unresolved NAMEs print an empty record and the exit status is 1.\n",
+         name, name, name);
+}
+
+/* resolve one name into 'out', returning non-zero if it was found */
+static int resolve_name(const char *root, const char *name, int canon, char *out, size_t outlen) {
+  if (!name[0])
+    return 0;
+
+  if (canon) {
+    strncpy(out, name, outlen - 1);
+    out[outlen - 1] = '\0';
+    resolve_to_full_path(root, out, outlen);
+  } else if (name[0] != '.' && !path_has_separator(name)) {
+    /* like 'command -v', report the PATH entry that matched */
+    return search_path(root, name, out, outlen);
+  } else {
+    ipwd_join(root, name, out, outlen);
+  }
+  if (!is_path_absolute(out))
+    return 0;
+
+#ifdef HAVE_SYS_STAT_H
+  {
+    struct stat st;
+    if (sys_stat(out, &st) != 0)
+      return 0;
+  }
+#endif
+  return 1;
+}
+
+static int emit(const char *root, const char *name, int canon, char delim) {
+  char out[MAXPATHLEN] = {0};
+  int found = resolve_name(root, name, canon, out, sizeof(out));
+
+  if (found)
+    fputs(out, stdout);
+  putchar(delim);
+  return found;
+}
+
+/* emit one --stdin name, rejecting one that did not fit in 'name' */
+static int emit_line(const char *root, char *name, int too_long, int canon, char delim) {
+  if (too_long) {
+    fprintf(stderr, "progpath: name longer than %d bytes\n", MAXPATHLEN - 1);
+    name[0] = '\0';
+  }
+  return emit(root, name, canon, delim);
+}
+
+static int batch(int ac, char *av[]) {
+  char root[MAXPATHLEN] = {0};
+  const char *root_arg = NULL;
+  char delim = '\n';
+  int canon = 0;
+  int from_stdin = 0;
+  int first_name = 0;
+  int missing = 0;
+  int i;
+
+  for (i = 1; i < ac && !first_name; i++) {
+    if (strcmp(av[i], "--root") == 0 && i + 1 < ac) {
+      root_arg = av[++i];
+    } else if (strcmp(av[i], "--canon") == 0) {
+      canon = 1;
+    } else if (strcmp(av[i], "-0") == 0) {
+      delim = '\0';
+    } else if (strcmp(av[i], "--stdin") == 0) {
+      from_stdin = 1;
+    } else if (strcmp(av[i], "--which") == 0) {
+      first_name = i + 1;
+    } else {
+      usage(av[0]);
+      return 2;
+    }
+  }
+  if (from_stdin == (first_name != 0) || (first_name && first_name >= ac)) {
+    usage(av[0]);
+    return 2;
+  }
+
+  /* a relative root is taken from the initial dir, once */
+  progipwd(root, MAXPATHLEN);
+  if (root_arg) {
+    char ipwd[MAXPATHLEN] = {0};
+    strncpy(ipwd, root, MAXPATHLEN - 1);
+    ipwd_join(ipwd, root_arg, root, MAXPATHLEN);
+  }
+
+  if (first_name) {
+    for (i = first_name; i < ac; i++)
+      missing |= !emit(root, av[i], canon, delim);
+  } else {
+    char name[MAXPATHLEN] = {0};
+    size_t len = 0;
+    int too_long = 0;
+    int c;
+
+    while ((c = getchar()) != EOF) {
+      if ((char)c == delim) {
+        name[len] = '\0';
+        missing |= !emit_line(root, name, too_long, canon, delim);
+        len = 0;
+        too_long = 0;
+      } else if (len < MAXPATHLEN - 1) {
+        name[len++] = (char)c;
+      } else {
+        too_long = 1;
+      }
+    }
+    if (len) {
+      name[len] = '\0';
+      missing |= !emit_line(root, name, too_long, canon, delim);
+    }
+  }
+
+  fflush(stdout);
+  return missing ? 1 : 0;
+}
+
 int main(int ac, char *av[]) {
   char *ipwd;
   char buf[1234] = {0};
 
-  if (ac > 1) {
-    printf("Usage: %s\n", av[0]);
-    return 1;
-  }
+  if (ac > 1)
+    return batch(ac, av);
 
   /* more challenging */
   chdir("../../../..");
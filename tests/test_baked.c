@@ -0,0 +1,73 @@
+/*                   T E S T _ B A K E D . C
+ * progpath
+ *
+ * Verifies the baked-path policies.  Built once per policy with
+ * PROGPATH_BAKED_POLICY set, and PROGPATH_BAKED_PATH defined here so
+ * each case can bake a different path: a path that does not exist, a
+ * directory that is not this executable, and this executable itself.
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+
+static const char *baked_path = "";
+#define PROGPATH_BAKED_PATH baked_path
+
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+/* bake 'path' and check what progpath() reports; NULL expects failure */
+static void check(const char *what, const char *path, const char *want) {
+  char got[MAXPATHLEN] = {0};
+  char *ret;
+
+  baked_path = path;
+  pp_state()->exe[0] = '\0';
+#if PROGPATH_BAKED_POLICY != PROGPATH_BAKED_TRUST
+  progpath_baked = 0;
+#endif
+  ret = progpath(got, sizeof(got));
+
+  if (want ? (!ret || strcmp(got, want) != 0) : ret != NULL) {
+    fprintf(stderr, "FAIL: %s: got [%s], expected [%s]\n", what, ret ? got : "(null)", want ? want : "(null)");
+    failures++;
+  } else {
+    printf("PASS: %s [%s]\n", what, ret ? got : "(null)");
+  }
+}
+
+int main(void) {
+  char self[MAXPATHLEN] = {0};
+  const char *bogus = "/nonexistent/progpath-baked";
+  char other[MAXPATHLEN] = {0};
+
+  if (!resolve_progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+  /* exists, but is not this executable */
+  if (!progipwd(other, sizeof(other)) || !other[0]) {
+    fprintf(stderr, "FAIL: progipwd() returned empty path\n");
+    return 1;
+  }
+
+  check("baked path turned off", "", self);
+  check("baked path is this executable", self, self);
+
+#if PROGPATH_BAKED_POLICY == PROGPATH_BAKED_TRUST
+  check("trusted missing path", bogus, bogus);
+  check("trusted other path", other, other);
+#elif PROGPATH_BAKED_POLICY == PROGPATH_BAKED_VERIFY
+  check("verified missing path", bogus, NULL);
+  check("verified other path", other, NULL);
+#else
+  check("missing path falls back", bogus, self);
+  check("other path falls back", other, self);
+#endif
+
+  return failures > 0 ? 1 : 0;
+}
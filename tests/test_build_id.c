@@ -0,0 +1,189 @@
+/*                T E S T _ B U I L D _ I D . C
+ * progpath
+ *
+ * Verifies progpath_build_id() against readelf's view of this test
+ * binary.  If readelf reports a GNU build-id, the same bytes must come
+ * back as PROGPATH_ID_BUILD.  If the binary has none (it is also built
+ * with -Wl,--build-id=none where the linker allows), the file identity
+ * fallback must come back as PROGPATH_ID_FILE and match stat().
+ *
+ * The implementation is compiled in so the note parser can also be fed
+ * a synthetic 8-byte aligned note segment, where padding from the
+ * start of the name instead of the note misplaces every field.
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_STAT_H)
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+
+/* 1 with 'hex' filled if readelf found a build-id, 0 if it found none,
+ * -1 if readelf could not be run.
+ */
+static int readelf_build_id(const char *path, char *hex, size_t len) {
+  char cmd[4096 + 64] = {0};
+  char line[1024] = {0};
+  int lines = 0;
+  int found = 0;
+  FILE *fp;
+
+  snprintf(cmd, sizeof(cmd), "readelf -n '%s' 2>/dev/null", path);
+  fp = popen(cmd, "r");
+  if (!fp)
+    return -1;
+  while (fgets(line, sizeof(line), fp)) {
+    const char *tag = strstr(line, "Build ID: ");
+    lines++;
+    if (tag && !found) {
+      size_t n;
+      strncpy(hex, tag + 10, len - 1);
+      n = strspn(hex, "0123456789abcdef");
+      hex[n] = '\0';
+      found = 1;
+    }
+  }
+  if (pclose(fp) != 0 && !lines)
+    return -1;
+  return found;
+}
+
+static unsigned long long unpack(const unsigned char *p) {
+  unsigned long long v = 0;
+  int i;
+  for (i = 0; i < 8; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+#if defined(HAVE_LINK_H) && (defined(HAVE_DL_ITERATE_PHDR) || (defined(HAVE_GETAUXVAL) && defined(HAVE_SYS_AUXV_H)))
+/* a vendor note with an odd name ahead of the build-id, 8-byte aligned */
+static int check_aligned_notes(void) {
+  static const unsigned char expected[4] = {0xde, 0xad, 0xbe, 0xef};
+  union {
+    unsigned char bytes[56];
+    unsigned long long align;
+  } seg;
+  ElfW(Nhdr) nh;
+  ElfW(Phdr) ph;
+  const unsigned char *desc;
+  size_t size = 0;
+
+  memset(&seg, 0, sizeof(seg));
+  nh.n_namesz = 5;
+  nh.n_descsz = 3;
+  nh.n_type = 1;
+  memcpy(seg.bytes, &nh, sizeof(nh));
+  memcpy(seg.bytes + 12, "ABCD", 5);
+  memcpy(seg.bytes + 24, "xyz", 3);
+  nh.n_namesz = 4;
+  nh.n_descsz = 4;
+  nh.n_type = NT_GNU_BUILD_ID;
+  memcpy(seg.bytes + 32, &nh, sizeof(nh));
+  memcpy(seg.bytes + 44, "GNU", 4);
+  memcpy(seg.bytes + 48, expected, 4);
+
+  memset(&ph, 0, sizeof(ph));
+  ph.p_type = PT_NOTE;
+  ph.p_vaddr = (ElfW(Addr))seg.bytes;
+  ph.p_memsz = sizeof(seg.bytes);
+  ph.p_align = 8;
+
+  desc = phdr_build_id(0, &ph, 1, &size);
+  if (!desc || size != 4 || memcmp(desc, expected, 4) != 0) {
+    fprintf(stderr, "FAIL: build-id not found in an 8-byte aligned note segment\n");
+    return 1;
+  }
+  printf("PASS: build-id found after a note in an 8-byte aligned segment\n");
+  return 0;
+}
+#else
+static int check_aligned_notes(void) {
+  return 0;
+}
+#endif
+
+int main(void) {
+  unsigned char id[256];
+  char self[4096] = {0};
+  char expected[1024] = {0};
+  char actual[sizeof(id) * 2 + 1] = {0};
+  size_t len = 0;
+  size_t i;
+  int kind;
+  int found;
+
+  if (!progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+
+  if (check_aligned_notes() != 0)
+    return 1;
+
+  /* a size query reports how much room is needed */
+  if (progpath_build_id(NULL, &len) != -1 || len == 0) {
+    fprintf(stderr, "FAIL: size query returned len=%lu\n", (unsigned long)len);
+    return 1;
+  }
+
+  len = sizeof(id);
+  kind = progpath_build_id(id, &len);
+  if (kind != PROGPATH_ID_BUILD && kind != PROGPATH_ID_FILE) {
+    fprintf(stderr, "FAIL: progpath_build_id() returned %d\n", kind);
+    return 1;
+  }
+  for (i = 0; i < len; i++)
+    snprintf(actual + i * 2, 3, "%02x", id[i]);
+
+  found = readelf_build_id(self, expected, sizeof(expected));
+  if (found < 0) {
+    printf("SKIP: readelf unavailable, got %s id %s\n", kind == PROGPATH_ID_BUILD ? "build" : "file", actual);
+    return 0;
+  }
+
+  if (found) {
+    if (kind != PROGPATH_ID_BUILD || strcmp(actual, expected) != 0) {
+      fprintf(stderr, "FAIL: readelf build-id %s, progpath_build_id() returned %d [%s]\n", expected, kind, actual);
+      return 1;
+    }
+    printf("PASS: build-id matches readelf [%s]\n", actual);
+  } else {
+    struct stat st;
+    if (kind != PROGPATH_ID_FILE || len != 40) {
+      fprintf(stderr, "FAIL: no build-id note, but progpath_build_id() returned %d with %lu bytes\n", kind, (unsigned long)len);
+      return 1;
+    }
+    if (stat(self, &st) != 0 || unpack(id) != (unsigned long long)st.st_dev || unpack(id + 8) != (unsigned long long)st.st_ino || unpack(id + 16) != (unsigned long long)st.st_size) {
+      fprintf(stderr, "FAIL: file identity [%s] does not match stat(%s)\n", actual, self);
+      return 1;
+    }
+    printf("PASS: no build-id, file identity matches stat() [%s]\n", actual);
+  }
+
+  /* a buffer one byte short is refused with the needed size */
+  i = len;
+  len = i - 1;
+  if (progpath_build_id(id, &len) != -1 || len != i) {
+    fprintf(stderr, "FAIL: short buffer not refused (len=%lu)\n", (unsigned long)len);
+    return 1;
+  }
+
+  return 0;
+}
+
+#else
+
+int main(void) {
+  printf("SKIP: build-id test requires readelf and stat()\n");
+  return 0;
+}
+
+#endif
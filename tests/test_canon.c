@@ -0,0 +1,212 @@
+/*                   T E S T _ C A N O N . C
+ * progpath
+ *
+ * Verifies progpath_canon() against realpath() over a small tree with
+ * relative and absolute symlinks, "." and "..", missing components, a
+ * file used as a directory, and a symlink loop.  Then checks that the
+ * cache makes a second path under a resolved directory cost a single
+ * lstat(), and that progpath_canon_invalidate() picks up a retargeted
+ * symlink.  lstat() calls are counted through PROGPATH_SYSCALL_SHIM.
+ * Where there are pthreads, also hammers the cache from several
+ * threads while one of them keeps emptying it.
+ *
+ * Only built where HAVE_LSTAT and HAVE_READLINK are detected.
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+#define PROGPATH_SYSCALL_SHIM 1
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREAD_H
+#  include <pthread.h>
+#endif
+
+#define TREE "canon_tree"
+#define THREADS 8
+#define THREAD_ITERATIONS 2000
+
+static int lstats = 0;
+
+static int counting_lstat(const char *path, struct stat *st) {
+  lstats++;
+  return lstat(path, st);
+}
+
+static const char *dirs[] = {TREE, TREE "/a", TREE "/a/b", TREE "/a/b/c", TREE "/a/b/c/d"};
+
+static const char *paths[] = {
+  TREE "/a/b/c/d/file",
+  TREE "/a/b/c/d/file2",
+  TREE "/a/b/c/d/",
+  TREE "/a/./b/../b/c",
+  TREE "/../" TREE "/a",
+  TREE "/rel/c/d/file",
+  TREE "/rel/../b/c",
+  TREE "/abs/b/c/d",
+  TREE "/abs/b/../../rel/c",
+  TREE "/a/b/c/d/file/..",
+  TREE "/a/b/c/d/file/",
+  TREE "/a/b/missing/d",
+  TREE "/loop/x",
+  "./" TREE "/a",
+  ".",
+  "/",
+};
+
+static int check(const char *path) {
+  char expected[MAXPATHLEN] = {0};
+  char result[MAXPATHLEN] = {0};
+  int want = realpath(path, expected) != NULL;
+  int got = progpath_canon(path, result, sizeof(result)) != NULL;
+
+  if (want != got || (want && strcmp(expected, result) != 0)) {
+    fprintf(stderr, "FAIL: [%s] resolved [%s], realpath() gives [%s]\n", path, got ? result : "(null)", want ? expected : "(null)");
+    return 1;
+  }
+  return 0;
+}
+
+#ifdef HAVE_PTHREAD_H
+static char expected_results[sizeof(paths) / sizeof(paths[0])][MAXPATHLEN];
+
+static void *hammer(void *arg) {
+  long id = (long)arg;
+  long mismatches = 0;
+  size_t npaths = sizeof(paths) / sizeof(paths[0]);
+  int i;
+
+  for (i = 0; i < THREAD_ITERATIONS; i++) {
+    size_t n = (size_t)(i + id) % npaths;
+    char result[MAXPATHLEN] = {0};
+    if (!progpath_canon(paths[n], result, sizeof(result)))
+      result[0] = '\0';
+    if (strcmp(result, expected_results[n]) != 0)
+      mismatches++;
+    if (id == 0 && i % 16 == 0)
+      progpath_canon_invalidate(NULL);
+  }
+  return (void *)mismatches;
+}
+
+static int check_threads(void) {
+  pthread_t threads[THREADS];
+  long mismatches = 0;
+  long i;
+
+  for (i = 0; i < (long)(sizeof(paths) / sizeof(paths[0])); i++) {
+    if (!realpath(paths[i], expected_results[i]))
+      expected_results[i][0] = '\0';
+  }
+  for (i = 0; i < THREADS; i++)
+    pthread_create(&threads[i], NULL, hammer, (void *)i);
+  for (i = 0; i < THREADS; i++) {
+    void *ret = NULL;
+    pthread_join(threads[i], &ret);
+    mismatches += (long)ret;
+  }
+  if (mismatches) {
+    fprintf(stderr, "FAIL: %ld results differ from realpath() across %d threads\n", mismatches, THREADS);
+    return 1;
+  }
+  printf("PASS: %d threads agree with realpath() while the cache is emptied\n", THREADS);
+  return 0;
+}
+#endif
+
+static void cleanup(void) {
+  int i;
+  unlink(TREE "/a/b/c/d/file");
+  unlink(TREE "/a/b/c/d/file2");
+  unlink(TREE "/rel");
+  unlink(TREE "/abs");
+  unlink(TREE "/loop");
+  unlink(TREE "/loop2");
+  for (i = (int)(sizeof(dirs) / sizeof(dirs[0])) - 1; i >= 0; i--)
+    rmdir(dirs[i]);
+}
+
+int main(void) {
+  char a[MAXPATHLEN] = {0};
+  char result[MAXPATHLEN] = {0};
+  char *allocated;
+  size_t i;
+  int failures = 0;
+  int first;
+  int second;
+
+  for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+    if (mkdir(dirs[i], 0777) != 0 && errno != EEXIST) {
+      fprintf(stderr, "FAIL: mkdir(%s) failed\n", dirs[i]);
+      return 1;
+    }
+  }
+  fclose(fopen(TREE "/a/b/c/d/file", "w"));
+  fclose(fopen(TREE "/a/b/c/d/file2", "w"));
+  if (!realpath(TREE "/a", a) || symlink("a/b", TREE "/rel") != 0 || symlink(a, TREE "/abs") != 0 ||
+      symlink("loop2", TREE "/loop") != 0 || symlink("loop", TREE "/loop2") != 0) {
+    fprintf(stderr, "FAIL: could not create the test tree\n");
+    cleanup();
+    return 1;
+  }
+#ifdef HAVE_PTHREAD_H
+  failures += check_threads();
+#endif
+  progpath_sys.lstat_fn = counting_lstat;
+
+  /* twice, so the second round runs from the cache */
+  for (i = 0; i < 2 * sizeof(paths) / sizeof(paths[0]); i++)
+    failures += check(paths[i % (sizeof(paths) / sizeof(paths[0]))]);
+  if (!failures)
+    printf("PASS: %d paths agree with realpath(), cold and cached\n", (int)(sizeof(paths) / sizeof(paths[0])));
+
+  /* a second file under a resolved directory only looks at itself */
+  progpath_canon_invalidate(NULL);
+  lstats = 0;
+  progpath_canon(TREE "/rel/c/d/file", result, sizeof(result));
+  first = lstats;
+  lstats = 0;
+  progpath_canon(TREE "/rel/c/d/file2", result, sizeof(result));
+  second = lstats;
+  if (second != 1) {
+    fprintf(stderr, "FAIL: cached lookup made %d lstat() calls, uncached made %d\n", second, first);
+    failures++;
+  } else {
+    printf("PASS: lstat() calls %d uncached, %d under a cached directory\n", first, second);
+  }
+
+  /* retarget a symlink and forget what was resolved through it */
+  unlink(TREE "/rel");
+  if (symlink("a/b/c", TREE "/rel") != 0) {
+    fprintf(stderr, "FAIL: could not retarget %s/rel\n", TREE);
+    failures++;
+  } else {
+    progpath_canon_invalidate(a);
+    if (check(TREE "/rel/d/file") || check(TREE "/rel/c")) {
+      failures++;
+    } else {
+      printf("PASS: invalidation picks up a retargeted symlink\n");
+    }
+  }
+
+  /* allocation and buffer size */
+  allocated = progpath_canon(TREE "/a", NULL, 0);
+  if (!allocated || strcmp(allocated, a) != 0) {
+    fprintf(stderr, "FAIL: allocated result [%s], expected [%s]\n", allocated ? allocated : "(null)", a);
+    failures++;
+  }
+  free(allocated);
+  if (progpath_canon(TREE "/a", result, strlen(a)) != NULL) {
+    fprintf(stderr, "FAIL: result written to a buffer without room for it\n");
+    failures++;
+  }
+
+  cleanup();
+  return failures > 0 ? 1 : 0;
+}
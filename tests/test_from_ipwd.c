@@ -0,0 +1,213 @@
+/*              T E S T _ F R O M _ I P W D . C
+ * progpath
+ *
+ * Verifies progpath_from_ipwd_batch() after the process has changed
+ * directories: relative paths resolve against the initial working
+ * directory to the same result as realpath(), missing paths yield an
+ * empty result, and the join-only mode and short output buffers
+ * behave as documented.  Also checks that closing the cached ipwd
+ * descriptor and reusing its number for another directory does not
+ * redirect later batches, and, in a child started inside a scratch
+ * directory, that renaming the initial directory does not lose it.
+ */
+
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_REALPATH)
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#  ifdef HAVE_SYS_WAIT_H
+#    include <sys/wait.h>
+#  endif
+
+#  define TREE "from_ipwd_tree"
+#  define MOVED "from_ipwd_moved"
+
+static int failures = 0;
+
+static void expect(const char *what, const char *got, const char *want) {
+  if (strcmp(got, want) != 0) {
+    fprintf(stderr, "FAIL: %s gave [%s], expected [%s]\n", what, got, want);
+    failures++;
+  } else {
+    printf("PASS: %s [%s]\n", what, got);
+  }
+}
+
+/* the child: its ipwd is renamed after the first batch opened it */
+static int renamed_ipwd(void) {
+  const char *file[] = {"file"};
+  char ipwd[4096] = {0};
+  char moved[4096] = {0};
+  char want[8192] = {0};
+  char out[8192];
+  size_t offs[1];
+  size_t done;
+
+  if (!progipwd(ipwd, sizeof(ipwd)) || !ipwd[0]) {
+    fprintf(stderr, "FAIL: progipwd() returned empty path\n");
+    return 1;
+  }
+  done = progpath_from_ipwd_batch(file, 1, out, sizeof(out), offs, 0);
+  if (done != 1 || !out[0]) {
+    fprintf(stderr, "FAIL: could not resolve %s/file\n", ipwd);
+    return 1;
+  }
+
+  snprintf(moved, sizeof(moved), "%s.moved", ipwd);
+  if (rename(ipwd, moved) != 0) {
+    fprintf(stderr, "FAIL: rename(%s) failed\n", ipwd);
+    return 1;
+  }
+  if (realpath(moved, want))
+    strncat(want, "/file", sizeof(want) - strlen(want) - 1);
+  done = progpath_from_ipwd_batch(file, 1, out, sizeof(out), offs, 0);
+  expect("batch after the ipwd was renamed", done == 1 ? out + offs[0] : "(short)", want);
+  rename(moved, ipwd);
+  return failures > 0 ? 1 : 0;
+}
+
+int main(int ac, char *av[]) {
+  const char *in[] = {
+    TREE "/sub/file",
+    "./" TREE "/link/file",
+    TREE "/sub/../sub/file",
+    TREE "/missing",
+    "",
+    "/",
+  };
+  const size_t n = sizeof(in) / sizeof(in[0]);
+  char ipwd[4096] = {0};
+  char want[4096] = {0};
+  char joined[8192] = {0};
+  char out[8192];
+  size_t offs[sizeof(in) / sizeof(in[0])];
+  size_t done;
+  FILE *fp;
+
+  if (ac > 1 && strcmp(av[1], "--renamed") == 0)
+    return renamed_ipwd();
+
+  if (!progipwd(ipwd, sizeof(ipwd)) || !ipwd[0]) {
+    fprintf(stderr, "FAIL: progipwd() returned empty path\n");
+    return 1;
+  }
+
+  mkdir(TREE, 0777);
+  mkdir(TREE "/sub", 0777);
+  fp = fopen(TREE "/sub/file", "w");
+  if (fp)
+    fclose(fp);
+  unlink(TREE "/link");
+  if (symlink("sub", TREE "/link") != 0 || !realpath(TREE "/sub/file", want)) {
+    fprintf(stderr, "FAIL: could not create %s\n", TREE);
+    return 1;
+  }
+
+  /* everything below must be independent of the current directory */
+  if (chdir("/") != 0) {
+    fprintf(stderr, "FAIL: chdir(/) failed\n");
+    return 1;
+  }
+
+  done = progpath_from_ipwd_batch(in, n, out, sizeof(out), offs, 0);
+  if (done != n) {
+    fprintf(stderr, "FAIL: resolved %lu of %lu paths\n", (unsigned long)done, (unsigned long)n);
+    return 1;
+  }
+  expect("relative path", out + offs[0], want);
+  expect("through symlink", out + offs[1], want);
+  expect("with ..", out + offs[2], want);
+  expect("missing path", out + offs[3], "");
+  expect("empty path", out + offs[4], "");
+  expect("absolute path", out + offs[5], "/");
+
+  /* join only: no symlink resolution, missing paths kept */
+  snprintf(joined, sizeof(joined), "%s/%s", ipwd, TREE "/link/file");
+  done = progpath_from_ipwd_batch(in, n, out, sizeof(out), offs, PROGPATH_BATCH_NO_CANON);
+  if (done != n) {
+    fprintf(stderr, "FAIL: joined %lu of %lu paths\n", (unsigned long)done, (unsigned long)n);
+    return 1;
+  }
+  expect("joined ./ path", out + offs[1], joined);
+  snprintf(joined, sizeof(joined), "%s/%s", ipwd, TREE "/missing");
+  expect("joined missing path", out + offs[3], joined);
+
+  done = progpath_from_ipwd_batch(in, n, out, sizeof(out), offs, PROGPATH_BATCH_NO_CANON | PROGPATH_BATCH_MUST_EXIST);
+  expect("joined missing path that must exist", done == n ? out + offs[3] : "(short)", "");
+
+  /* room for only the first result */
+  done = progpath_from_ipwd_batch(in, n, out, strlen(want) + 1, offs, 0);
+  if (done != 1 || strcmp(out + offs[0], want) != 0) {
+    fprintf(stderr, "FAIL: short buffer resolved %lu paths\n", (unsigned long)done);
+    failures++;
+  } else {
+    printf("PASS: short buffer stops after the first result\n");
+  }
+
+  /* close everything, as daemons do, and hand the number to another dir */
+  {
+    const char *file[] = {"file"};
+    int fd;
+    for (fd = 3; fd < 256; fd++)
+      close(fd);
+    snprintf(joined, sizeof(joined), "%s/%s", ipwd, TREE "/sub");
+    fd = open(joined, O_RDONLY);
+    done = progpath_from_ipwd_batch(file, 1, out, sizeof(out), offs, 0);
+    expect("batch after its descriptor was reused", done == 1 ? out + offs[0] : "(short)", "");
+    if (fd >= 0)
+      close(fd);
+  }
+
+#  ifdef HAVE_SYS_WAIT_H
+  /* descriptors are only named back to paths through procfs */
+  if (access("/proc/self/fd", F_OK) == 0) {
+    char self[4096] = {0};
+    int status = -1;
+    pid_t pid = -1;
+
+    snprintf(joined, sizeof(joined), "%s/%s", ipwd, MOVED);
+    mkdir(joined, 0777);
+    snprintf(want, sizeof(want), "%s/file", joined);
+    fp = fopen(want, "w");
+    if (fp)
+      fclose(fp);
+    if (!progpath(self, sizeof(self)) || !fp) {
+      fprintf(stderr, "FAIL: could not set up %s\n", joined);
+      failures++;
+    } else if (fflush(stdout) == 0 && (pid = fork()) == 0) {
+      if (chdir(joined) == 0 && setenv("PWD", joined, 1) == 0)
+        execl(self, self, "--renamed", (char *)NULL);
+      _exit(127);
+    } else if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "FAIL: renamed ipwd child failed\n");
+      failures++;
+    }
+    unlink(want);
+    rmdir(joined);
+  }
+#  endif
+
+  if (chdir(ipwd) == 0) {
+    unlink(TREE "/link");
+    unlink(TREE "/sub/file");
+    rmdir(TREE "/sub");
+    rmdir(TREE);
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+#else
+
+int main(void) {
+  printf("SKIP: batch ipwd test requires chdir(), stat(), and realpath()\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*                T E S T _ I N I T _ A R G S . C
+ * progpath
+ *
+ * Verifies the argv[0]/PATH/PWD capture done by the constructor where
+ * the loader passes (argc, argv, envp) to it.  The test re-executes
+ * itself by bare name through a PATH search so argv[0] carries no
+ * directory, then resolves progpath() twice: once from the captured
+ * values and once through the legacy method chain.  Both must agree,
+ * and the captured run must not need the environment or more
+ * filesystem calls than the legacy run.
+ *
+ * Library calls made by the implementation are counted by compiling
+ * it into this file with those calls redirected to counting wrappers.
+ * Only built where HAVE_INIT_ARRAY_ARGS is detected.
+ */
+
+#define _GNU_SOURCE 1
+#define PROGPATH_NO_C_INIT_WARNING 1
+
+/* system declarations first, so the redirects below only affect calls */
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+enum { C_GETENV_PATH_PWD, C_GETENV, C_READLINK, C_OPEN, C_ACCESS, C_REALPATH, C_COUNT };
+static int counts[C_COUNT];
+
+static char *counted_getenv(const char *name);
+static ssize_t counted_readlink(const char *path, char *buf, size_t len);
+static int counted_open(const char *path, int flags, ...);
+static int counted_access(const char *path, int mode);
+static char *counted_realpath(const char *path, char *resolved);
+
+#define getenv counted_getenv
+#define readlink counted_readlink
+#define open counted_open
+#define access counted_access
+#define realpath counted_realpath
+
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#undef getenv
+#undef readlink
+#undef open
+#undef access
+#undef realpath
+
+static char *counted_getenv(const char *name) {
+  counts[C_GETENV]++;
+  if (strcmp(name, "PATH") == 0 || strcmp(name, "PWD") == 0)
+    counts[C_GETENV_PATH_PWD]++;
+  return getenv(name);
+}
+
+static ssize_t counted_readlink(const char *path, char *buf, size_t len) {
+  counts[C_READLINK]++;
+  return readlink(path, buf, len);
+}
+
+static int counted_open(const char *path, int flags, ...) {
+  counts[C_OPEN]++;
+  return open(path, flags);
+}
+
+static int counted_access(const char *path, int mode) {
+  counts[C_ACCESS]++;
+  return access(path, mode);
+}
+
+static char *counted_realpath(const char *path, char *resolved) {
+  counts[C_REALPATH]++;
+  return realpath(path, resolved);
+}
+
+static int filesystem_calls(void) {
+  return counts[C_READLINK] + counts[C_OPEN] + counts[C_ACCESS] + counts[C_REALPATH];
+}
+
+static void report(const char *label) {
+  printf("%-8s getenv=%d (PATH/PWD=%d) readlink=%d open=%d access=%d realpath=%d\n",
+         label, counts[C_GETENV], counts[C_GETENV_PATH_PWD], counts[C_READLINK],
+         counts[C_OPEN], counts[C_ACCESS], counts[C_REALPATH]);
+}
+
+static int child(const char *argv0) {
+  struct progpath_state *state = pp_state();
+  char captured[MAXPATHLEN] = {0};
+  char legacy[MAXPATHLEN] = {0};
+  int captured_fs;
+  int ret = 0;
+
+  if (!state->have_args || !state->argv0 || strcmp(state->argv0, argv0) != 0) {
+    fprintf(stderr, "FAIL: constructor did not capture argv[0] [%s]\n", state->argv0 ? state->argv0 : "(null)");
+    return 1;
+  }
+  if (!state->env_path || strcmp(state->env_path, getenv("PATH")) != 0) {
+    fprintf(stderr, "FAIL: constructor did not capture PATH\n");
+    return 1;
+  }
+  printf("PASS: constructor captured argv[0] [%s] and PATH\n", state->argv0);
+
+  memset(counts, 0, sizeof(counts));
+  if (!resolve_progpath(captured, sizeof(captured))) {
+    fprintf(stderr, "FAIL: progpath() from captured argv[0] failed\n");
+    return 1;
+  }
+  report("captured");
+  captured_fs = filesystem_calls();
+  if (counts[C_GETENV_PATH_PWD] != 0) {
+    fprintf(stderr, "FAIL: captured resolution still read PATH/PWD from the environment\n");
+    ret = 1;
+  }
+
+  /* forget the capture to exercise the legacy chain */
+  state->have_args = 0;
+  state->argv0 = NULL;
+  memset(counts, 0, sizeof(counts));
+  if (!resolve_progpath(legacy, sizeof(legacy))) {
+    fprintf(stderr, "FAIL: progpath() from legacy chain failed\n");
+    return 1;
+  }
+  report("legacy");
+
+  if (strcmp(captured, legacy) != 0) {
+    fprintf(stderr, "FAIL: captured [%s] != legacy [%s]\n", captured, legacy);
+    ret = 1;
+  } else {
+    printf("PASS: captured and legacy results agree [%s]\n", captured);
+  }
+  if (captured_fs > filesystem_calls()) {
+    fprintf(stderr, "FAIL: captured resolution made %d filesystem calls, legacy made %d\n", captured_fs, filesystem_calls());
+    ret = 1;
+  }
+
+  return ret;
+}
+
+int main(int ac, char *av[]) {
+  char self[MAXPATHLEN] = {0};
+  char path[MAXPATHLEN * 2] = {0};
+  const char *base;
+  char *slash;
+  int status = 0;
+  pid_t pid;
+
+  if (ac > 1 && strcmp(av[1], "--child") == 0)
+    return child(av[0]);
+
+  if (!progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+  slash = strrchr(self, '/');
+  if (!slash) {
+    fprintf(stderr, "FAIL: progpath() returned [%s]\n", self);
+    return 1;
+  }
+  *slash = '\0';
+  base = slash + 1;
+
+  /* a few misses before the hit make the PATH search do some work */
+  snprintf(path, sizeof(path), "/nonexistent/a:/nonexistent/b:%s", self);
+
+  pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "FAIL: fork() failed\n");
+    return 1;
+  }
+  if (pid == 0) {
+    setenv("PATH", path, 1);
+    execlp(base, base, "--child", (char *)NULL);
+    _exit(127);
+  }
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+    fprintf(stderr, "FAIL: child did not exit cleanly\n");
+    return 1;
+  }
+  return WEXITSTATUS(status);
+}
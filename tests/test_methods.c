@@ -0,0 +1,294 @@
+/*                  T E S T _ M E T H O D S . C
+ * progpath
+ *
+ * Exercises procfs-based methods one at a time, regardless of which
+ * method would win on the host, using the PROGPATH_SYSCALL_SHIM test
+ * hook.  Each case builds a fake procfs tree pointing at a fake
+ * executable, enables only the method under test, and checks that it
+ * resolves the fake executable.  Each case reports the system calls
+ * made by that method and the time for a whole lookup, and fails if
+ * a disabled method made any calls of its own.  Also checks
+ * that an injected failure falls through to the next method, and that
+ * nothing is returned when every method is disabled.
+ *
+ * Only built where HAVE_READLINK is detected.
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+#define PROGPATH_SYSCALL_SHIM 1
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ROOT "methods_proc_root"
+#define FAKE_DIR "methods_fake_bin"
+#define ITERATIONS 200
+
+enum kind { LINK, FILE_CONTENT };
+
+struct method_case {
+  const char *label;
+  enum kind kind;
+  const char *entry; /* relative to the fake root, %d is the pid */
+};
+
+static const struct method_case cases[] = {
+  {"readlink(/proc/self/exe)", LINK, "self/exe"},
+#ifdef HAVE_READ
+  {"readlink(/proc/self/exefile)", FILE_CONTENT, "self/exefile"},
+#endif
+  {"readlink(/proc/curproc/file)", LINK, "curproc/file"},
+  {"readlink(/proc/curproc/exe)", LINK, "curproc/exe"},
+  {"readlink(/proc/$PID/file)", LINK, "%d/file"},
+  {"readlink(/proc/$PID/cmdline)", LINK, "%d/cmdline"},
+#ifdef HAVE_READ
+  {"read(/proc/$PID/cmdline)", FILE_CONTENT, "%d/cmdline"},
+#endif
+  {"readlink(/proc/$PID/path/a.out)", LINK, "%d/path/a.out"},
+  {"readlink(/proc/self/path/a.out)", LINK, "self/path/a.out"},
+  {"readlink(/proc/pinfo)", LINK, "pinfo"},
+  {"readlink(/proc/$PID)", LINK, "%d"},
+};
+
+static const char *enabled_labels[3] = {NULL, NULL, NULL};
+static const char *fail_suffix = NULL;
+static int calls = 0;
+static int stray = 0;
+
+static int only_enabled(const char *label) {
+  int i;
+  if (strcmp(label, "getcwd") == 0)
+    return 1;
+  for (i = 0; enabled_labels[i]; i++) {
+    if (strcmp(label, enabled_labels[i]) == 0)
+      return 1;
+  }
+  return 0;
+}
+
+/* only count calls made on behalf of the method being measured, and
+ * note any made by a method that should have been skipped
+ */
+static void count_call(void) {
+  if (progpath_sys.method && enabled_labels[0] && strcmp(progpath_sys.method, enabled_labels[0]) == 0)
+    calls++;
+  else if (progpath_sys.method && !only_enabled(progpath_sys.method))
+    stray++;
+}
+
+static int ends_with(const char *str, const char *suffix) {
+  size_t len = strlen(str);
+  size_t slen = strlen(suffix);
+  return len >= slen && strcmp(str + len - slen, suffix) == 0;
+}
+
+static ssize_t counting_readlink(const char *path, char *buf, size_t len) {
+  count_call();
+  if (fail_suffix && ends_with(path, fail_suffix)) {
+    errno = EACCES;
+    return -1;
+  }
+  return readlink(path, buf, len);
+}
+
+#ifdef HAVE_READ
+static int counting_open(const char *path, int flags) {
+  count_call();
+  return open(path, flags);
+}
+
+static long counting_read(int fd, void *buf, size_t len) {
+  count_call();
+  return (long)read(fd, buf, len);
+}
+#endif
+
+static char *counting_realpath(const char *path, char *resolved) {
+  count_call();
+  return realpath(path, resolved);
+}
+
+static long now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+/* create 'entry' under ROOT as a symlink to, or a file naming, 'target' */
+static int make_entry(const char *entry, enum kind kind, const char *target) {
+  char path[MAXPATHLEN] = {0};
+  char *p;
+
+  snprintf(path, sizeof(path), "%s/", ROOT);
+  snprintf(path + strlen(path), sizeof(path) - strlen(path), entry, (int)getpid());
+
+  for (p = path + strlen(ROOT) + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      if (mkdir(path, 0777) != 0 && errno != EEXIST)
+        return -1;
+      *p = '/';
+    }
+  }
+
+  if (kind == LINK)
+    return symlink(target, path);
+
+  {
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+      return -1;
+    fwrite(target, 1, strlen(target) + 1, fp);
+    fclose(fp);
+  }
+  return 0;
+}
+
+/* remove 'entry' and then any directories it needed */
+static void remove_entry(const char *entry) {
+  char path[MAXPATHLEN] = {0};
+  char *slash;
+
+  snprintf(path, sizeof(path), "%s/", ROOT);
+  snprintf(path + strlen(path), sizeof(path) - strlen(path), entry, (int)getpid());
+  unlink(path);
+  while ((slash = strrchr(path, '/')) != NULL && slash > path + strlen(ROOT)) {
+    *slash = '\0';
+    rmdir(path);
+  }
+}
+
+static int make_fake_exe(const char *name, char *real, size_t len) {
+  char path[MAXPATHLEN] = {0};
+  char rp[MAXPATHLEN] = {0};
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s/%s", FAKE_DIR, name);
+  fp = fopen(path, "wb");
+  if (!fp)
+    return -1;
+  fclose(fp);
+  if (!realpath(path, rp))
+    return -1;
+  strncpy(real, rp, len - 1);
+  return 0;
+}
+
+int main(void) {
+  char tool[MAXPATHLEN] = {0};
+  char other[MAXPATHLEN] = {0};
+  char result[MAXPATHLEN] = {0};
+  size_t i;
+  int failures = 0;
+
+  if (mkdir(FAKE_DIR, 0777) != 0 && errno != EEXIST) {
+    fprintf(stderr, "FAIL: mkdir(%s) failed\n", FAKE_DIR);
+    return 1;
+  }
+  if (mkdir(ROOT, 0777) != 0 && errno != EEXIST) {
+    fprintf(stderr, "FAIL: mkdir(%s) failed\n", ROOT);
+    return 1;
+  }
+  if (make_fake_exe("tool", tool, sizeof(tool)) != 0 || make_fake_exe("other", other, sizeof(other)) != 0) {
+    fprintf(stderr, "FAIL: could not create fake executables\n");
+    return 1;
+  }
+
+  progpath_sys.proc_root = ROOT;
+  progpath_sys.enabled = only_enabled;
+  progpath_sys.readlink_fn = counting_readlink;
+  progpath_sys.realpath_fn = counting_realpath;
+#ifdef HAVE_READ
+  progpath_sys.open_fn = counting_open;
+  progpath_sys.read_fn = counting_read;
+#endif
+
+  /* each method alone against its own fake tree */
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const struct method_case *c = &cases[i];
+    long start;
+    int n;
+
+    if (make_entry(c->entry, c->kind, tool) != 0) {
+      fprintf(stderr, "FAIL: could not create fake %s\n", c->entry);
+      failures++;
+      continue;
+    }
+
+    enabled_labels[0] = c->label;
+    memset(result, 0, sizeof(result));
+    if (!resolve_progpath(result, sizeof(result)) || strcmp(result, tool) != 0) {
+      fprintf(stderr, "FAIL: %s resolved [%s], expected [%s]\n", c->label, result, tool);
+      failures++;
+    } else {
+      calls = 0;
+      stray = 0;
+      progpath_sys.method = NULL;
+      start = now_us();
+      for (n = 0; n < ITERATIONS; n++)
+        resolve_progpath(result, sizeof(result));
+      if (stray) {
+        fprintf(stderr, "FAIL: %s lookup made %d calls in disabled methods\n", c->label, stray);
+        failures++;
+      } else {
+        printf("PASS: %-34s %6.2f us/lookup, %4.1f calls in method\n", c->label,
+               (double)(now_us() - start) / ITERATIONS, (double)calls / ITERATIONS);
+      }
+    }
+
+    remove_entry(c->entry);
+  }
+
+  /* an injected failure falls through to the next method */
+  enabled_labels[0] = "readlink(/proc/self/exe)";
+  enabled_labels[1] = "readlink(/proc/curproc/file)";
+  if (make_entry("self/exe", LINK, tool) != 0 || make_entry("curproc/file", LINK, other) != 0) {
+    fprintf(stderr, "FAIL: could not create fake self/exe and curproc/file\n");
+    failures++;
+  } else {
+    memset(result, 0, sizeof(result));
+    resolve_progpath(result, sizeof(result));
+    if (strcmp(result, tool) != 0) {
+      fprintf(stderr, "FAIL: expected self/exe to win [%s], got [%s]\n", tool, result);
+      failures++;
+    }
+
+    fail_suffix = "/self/exe";
+    memset(result, 0, sizeof(result));
+    resolve_progpath(result, sizeof(result));
+    fail_suffix = NULL;
+    if (strcmp(result, other) != 0) {
+      fprintf(stderr, "FAIL: expected fall through to curproc/file [%s], got [%s]\n", other, result);
+      failures++;
+    } else {
+      printf("PASS: failing readlink(self/exe) falls through to curproc/file\n");
+    }
+  }
+  remove_entry("self/exe");
+  remove_entry("curproc/file");
+  enabled_labels[1] = NULL;
+
+  /* nothing enabled means nothing found */
+  enabled_labels[0] = "no such method";
+  memset(result, 0, sizeof(result));
+  if (resolve_progpath(result, sizeof(result)) || result[0]) {
+    fprintf(stderr, "FAIL: resolved [%s] with every method disabled\n", result);
+    failures++;
+  } else {
+    printf("PASS: no result with every method disabled\n");
+  }
+
+  unlink(FAKE_DIR "/tool");
+  unlink(FAKE_DIR "/other");
+  rmdir(FAKE_DIR);
+  rmdir(ROOT);
+
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+/*                  T E S T _ P L U G I N . C
+ * progpath
+ *
+ * A loadable module embedding its own copy of the implementation, as
+ * plugins do.  Built as two separate modules for test_shared_state,
+ * and as two more linked with test_plugin.map, which exports only the
+ * plugin_* entry points.
+ */
+
+#define PROGPATH_NO_C_INIT_WARNING 1
+#define PROGPATH_IMPLEMENTATION
+#include "progpath.h"
+
+#define PLUGIN_EXPORT __attribute__((visibility("default")))
+
+PLUGIN_EXPORT char *plugin_ipwd(char *buf, size_t len) {
+  return progipwd(buf, len);
+}
+
+PLUGIN_EXPORT const void *plugin_state(void) {
+  return pp_state();
+}
+
+PLUGIN_EXPORT int plugin_copies(void) {
+  return pp_state()->copies;
+}
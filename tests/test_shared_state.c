@@ -0,0 +1,125 @@
+/*             T E S T _ S H A R E D _ S T A T E . C
+ * progpath
+ *
+ * Verifies that copies of the implementation embedded in separate
+ * plugins share one process-wide state.  The first plugin is loaded
+ * before a chdir(), the second after it with PWD changed to match,
+ * both RTLD_LOCAL so neither can see the other's symbols directly.
+ * The late plugin must attach to the first one's state and report the
+ * original initial working directory.
+ *
+ * Built a second time with EMBED_IMPLEMENTATION, where this program
+ * carries its own copy but exports no symbols (no -rdynamic).  Both
+ * plugins are then loaded after the chdir() and must attach to the
+ * program's state.  Built a third time against plugins whose version
+ * script keeps progpath_state_v2 local to each of them.
+ */
+
+#ifdef EMBED_IMPLEMENTATION
+#  define PROGPATH_NO_C_INIT_WARNING 1
+#  define PROGPATH_IMPLEMENTATION
+#  include "progpath.h"
+#endif
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef char *(*ipwd_fn)(char *, size_t);
+typedef const void *(*state_fn)(void);
+typedef int (*copies_fn)(void);
+
+struct plugin {
+  void *handle;
+  ipwd_fn ipwd;
+  state_fn state;
+  copies_fn copies;
+};
+
+static int load(const char *path, struct plugin *p) {
+  p->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (!p->handle) {
+    fprintf(stderr, "FAIL: dlopen(%s): %s\n", path, dlerror());
+    return -1;
+  }
+  *(void **)&p->ipwd = dlsym(p->handle, "plugin_ipwd");
+  *(void **)&p->state = dlsym(p->handle, "plugin_state");
+  *(void **)&p->copies = dlsym(p->handle, "plugin_copies");
+  if (!p->ipwd || !p->state || !p->copies) {
+    fprintf(stderr, "FAIL: %s is missing plugin symbols\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+int main(void) {
+  struct plugin a;
+  struct plugin b;
+  char cwd[4096] = {0};
+  char start[4096] = {0};
+  char ipwd_a[4096] = {0};
+  char ipwd_b[4096] = {0};
+  int failures = 0;
+#ifdef EMBED_IMPLEMENTATION
+  const int copies = 3;
+#else
+  const int copies = 2;
+#endif
+
+  if (!getcwd(cwd, sizeof(cwd)) || !realpath(cwd, start)) {
+    fprintf(stderr, "FAIL: getcwd() failed\n");
+    return 1;
+  }
+
+#ifndef EMBED_IMPLEMENTATION
+  if (load(PLUGIN_A, &a) != 0)
+    return 1;
+#endif
+
+  /* anything resolved from scratch from here on would see "/" */
+  if (chdir("/") != 0 || setenv("PWD", "/", 1) != 0) {
+    fprintf(stderr, "FAIL: chdir(/) failed\n");
+    return 1;
+  }
+
+#ifdef EMBED_IMPLEMENTATION
+  if (load(PLUGIN_A, &a) != 0)
+    return 1;
+  if (a.state() != (const void *)pp_state()) {
+    fprintf(stderr, "FAIL: plugin state %p is not the program's %p\n", a.state(), (void *)pp_state());
+    failures++;
+  } else {
+    printf("PASS: plugin attached to the program's state\n");
+  }
+#endif
+
+  if (load(PLUGIN_B, &b) != 0)
+    return 1;
+
+  if (a.state() != b.state()) {
+    fprintf(stderr, "FAIL: plugins have separate states %p and %p\n", a.state(), b.state());
+    failures++;
+  } else {
+    printf("PASS: plugins share one state (%d copies attached)\n", a.copies());
+  }
+  if (a.copies() != copies) {
+    fprintf(stderr, "FAIL: expected %d copies attached, found %d\n", copies, a.copies());
+    failures++;
+  }
+
+  a.ipwd(ipwd_a, sizeof(ipwd_a));
+  b.ipwd(ipwd_b, sizeof(ipwd_b));
+  if (strcmp(ipwd_a, start) != 0 || strcmp(ipwd_b, start) != 0) {
+    fprintf(stderr, "FAIL: ipwd [%s] and [%s], expected [%s]\n", ipwd_a, ipwd_b, start);
+    failures++;
+  } else {
+    printf("PASS: late plugin inherited ipwd [%s]\n", ipwd_b);
+  }
+
+  dlclose(b.handle);
+  dlclose(a.handle);
+  return failures > 0 ? 1 : 0;
+}
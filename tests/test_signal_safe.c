@@ -0,0 +1,71 @@
+/*              T E S T _ S I G N A L _ S A F E . C
+ * progpath
+ *
+ * Calls progpath_signal_safe() from inside a signal handler, both
+ * before progpath() has published a path (procfs fallback) and after,
+ * and checks the handler saw the same path progpath() reports.  Also
+ * checks that a buffer too small for the path is refused.
+ */
+
+#include "progpath.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+static char handler_buf[4096];
+static char *volatile handler_ret;
+static volatile size_t handler_len;
+
+static void handler(int sig) {
+  (void)sig;
+  handler_ret = progpath_signal_safe(handler_buf, handler_len);
+}
+
+static char *from_handler(size_t len) {
+  handler_buf[0] = '\0';
+  handler_ret = NULL;
+  handler_len = len;
+  raise(SIGABRT);
+  return handler_ret;
+}
+
+int main(void) {
+  char self[4096] = {0};
+  char *ret;
+  int failures = 0;
+
+  signal(SIGABRT, handler);
+
+  /* before any progpath() call */
+  ret = from_handler(sizeof(handler_buf));
+  if (!progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+  if (ret && strcmp(ret, self) != 0) {
+    fprintf(stderr, "FAIL: unpublished handler path [%s] != progpath() [%s]\n", ret, self);
+    failures++;
+  } else {
+    printf("PASS: before progpath() [%s]\n", ret ? ret : "(null, no procfs)");
+  }
+
+  /* after progpath() has published its result */
+  ret = from_handler(sizeof(handler_buf));
+  if (!ret || strcmp(ret, self) != 0) {
+    fprintf(stderr, "FAIL: published handler path [%s] != progpath() [%s]\n", ret ? ret : "(null)", self);
+    failures++;
+  } else {
+    printf("PASS: after progpath() [%s]\n", ret);
+  }
+
+  ret = from_handler(strlen(self));
+  if (ret || handler_buf[0]) {
+    fprintf(stderr, "FAIL: truncated path returned [%s]\n", handler_buf);
+    failures++;
+  } else {
+    printf("PASS: buffer one byte short is refused\n");
+  }
+
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+/*                   T E S T _ W A T C H . C
+ * progpath
+ *
+ * Verifies that progpath_watch() notices when the running executable
+ * is replaced on disk.  The test copies itself into a scratch
+ * directory, runs the copy as a watcher child, renames a fresh copy
+ * over it, and checks that the child's callback reports the
+ * replacement promptly.  It then rewrites the new file in several
+ * writes and checks that, with inotify, the rewrite is reported once.
+ * Last, it removes the file and writes a new one in its place slowly,
+ * and checks that the replacement is not reported before it is whole.
+ */
+
+#include "progpath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_WAIT_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_FCNTL_H)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <sys/stat.h>
+#  include <sys/time.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+
+#  define WATCH_DIR "watch_test_dir"
+#  define TIMEOUT_MS 5000
+
+#  define REWRITES 5
+#  define REWRITE_GAP_MS 50
+#  define SLOW_CHUNK 4096
+#  define SLOW_GAP_MS 20
+
+/* where the watch is event driven, partial writes are never reported */
+#  if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT1)
+#    define EXPECTED_MS 1000
+#    define WATCH_EVENTS 1
+#  else
+#    define EXPECTED_MS (PROGPATH_WATCH_INTERVAL_MS * 3)
+#    define WATCH_EVENTS 0
+#  endif
+
+/* reports the events and the file's size, stopping at the third replacement */
+static int child_callback(const char *path, int events, void *user) {
+  static int replaced = 0;
+  struct stat st;
+  (void)user;
+  printf("%s %d %ld\n", events == PROGPATH_WATCH_ARMED ? "armed" : "event", events,
+         stat(path, &st) == 0 ? (long)st.st_size : -1L);
+  fflush(stdout);
+  if (events & PROGPATH_WATCH_REPLACED)
+    replaced++;
+  return replaced >= 3;
+}
+
+/* copy 'src' to 'dst', pausing 'gap_ms' between small writes if non-zero */
+static int copy_file(const char *src, const char *dst, int gap_ms) {
+  char buf[65536];
+  size_t chunk = gap_ms ? SLOW_CHUNK : sizeof(buf);
+  ssize_t n;
+  int in = open(src, O_RDONLY);
+  int out;
+
+  if (in < 0) {
+    fprintf(stderr, "FAIL: open(%s) failed\n", src);
+    return -1;
+  }
+  out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+  if (out < 0) {
+    fprintf(stderr, "FAIL: open(%s) failed\n", dst);
+    close(in);
+    return -1;
+  }
+  while ((n = read(in, buf, chunk)) > 0) {
+    if (write(out, buf, (size_t)n) != n) {
+      n = -1;
+      break;
+    }
+    if (gap_ms)
+      poll(NULL, 0, gap_ms);
+  }
+  close(in);
+  close(out);
+  return n < 0 ? -1 : 0;
+}
+
+static long now_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (long)tv.tv_sec * 1000L + (long)(tv.tv_usec / 1000);
+}
+
+/* read one line from the child within 'timeout' milliseconds */
+static int read_line(int fd, char *line, size_t len, int timeout) {
+  size_t used = 0;
+  long deadline = now_ms() + timeout;
+
+  while (used + 1 < len) {
+    struct pollfd pfd;
+    long left = deadline - now_ms();
+    char c;
+
+    if (left <= 0)
+      return -1;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, (int)left) <= 0)
+      continue;
+    if (read(fd, &c, 1) != 1)
+      return -1;
+    if (c == '\n')
+      break;
+    line[used++] = c;
+  }
+  line[used] = '\0';
+  return 0;
+}
+
+/* append to 'path' in several spaced writes through one descriptor */
+static int rewrite_file(const char *path) {
+  char chunk[512];
+  int i;
+  int fd = open(path, O_WRONLY | O_APPEND);
+
+  if (fd < 0) {
+    fprintf(stderr, "FAIL: open(%s) failed\n", path);
+    return -1;
+  }
+  memset(chunk, 0, sizeof(chunk));
+  for (i = 0; i < REWRITES; i++) {
+    if (write(fd, chunk, sizeof(chunk)) != (ssize_t)sizeof(chunk)) {
+      fprintf(stderr, "FAIL: write(%s) failed\n", path);
+      close(fd);
+      return -1;
+    }
+    poll(NULL, 0, REWRITE_GAP_MS);
+  }
+  close(fd);
+  return 0;
+}
+
+int main(int ac, char *av[]) {
+  char self[4096] = {0};
+  char watched[4096] = {0};
+  char incoming[4096] = {0};
+  char line[256] = {0};
+  struct stat st;
+  long size;
+  int pipefd[2];
+  int status = 0;
+  int modified = 0;
+  int ret = 1;
+  long start;
+  long elapsed;
+  pid_t pid;
+
+  if (ac > 1 && strcmp(av[1], "--child") == 0)
+    return progpath_watch(child_callback, NULL) == 0 ? 0 : 1;
+
+  if (!progpath(self, sizeof(self)) || !self[0]) {
+    fprintf(stderr, "FAIL: progpath() returned empty path\n");
+    return 1;
+  }
+
+  errno = 0;
+  if (mkdir(WATCH_DIR, 0777) != 0 && errno != EEXIST) {
+    fprintf(stderr, "FAIL: mkdir(%s) failed\n", WATCH_DIR);
+    return 1;
+  }
+  snprintf(watched, sizeof(watched), "%s/watched", WATCH_DIR);
+  snprintf(incoming, sizeof(incoming), "%s/watched.new", WATCH_DIR);
+  if (copy_file(self, watched, 0) != 0)
+    return 1;
+
+  if (pipe(pipefd) != 0) {
+    fprintf(stderr, "FAIL: pipe() failed\n");
+    return 1;
+  }
+
+  pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "FAIL: fork() failed\n");
+    return 1;
+  }
+  if (pid == 0) {
+    close(pipefd[0]);
+    dup2(pipefd[1], STDOUT_FILENO);
+    execl(watched, watched, "--child", (char *)NULL);
+    _exit(127);
+  }
+  close(pipefd[1]);
+
+  if (read_line(pipefd[0], line, sizeof(line), TIMEOUT_MS) != 0 || strncmp(line, "armed", 5) != 0) {
+    fprintf(stderr, "FAIL: watcher never armed [%s]\n", line);
+    goto cleanup;
+  }
+
+  /* deploy a new build the usual way, atomically over the old one */
+  if (copy_file(self, incoming, 0) != 0)
+    goto cleanup;
+  start = now_ms();
+  if (rename(incoming, watched) != 0) {
+    fprintf(stderr, "FAIL: rename(%s, %s) failed\n", incoming, watched);
+    goto cleanup;
+  }
+
+  if (read_line(pipefd[0], line, sizeof(line), TIMEOUT_MS) != 0) {
+    fprintf(stderr, "FAIL: no callback within %d ms of replacement\n", TIMEOUT_MS);
+    goto cleanup;
+  }
+  elapsed = now_ms() - start;
+
+  if (strncmp(line, "event", 5) != 0 || !(atoi(line + 6) & PROGPATH_WATCH_REPLACED)) {
+    fprintf(stderr, "FAIL: expected a replacement event, got [%s]\n", line);
+    goto cleanup;
+  }
+  if (elapsed > EXPECTED_MS) {
+    fprintf(stderr, "FAIL: replacement noticed after %ld ms (expected <= %d ms)\n", elapsed, EXPECTED_MS);
+    goto cleanup;
+  }
+
+  printf("PASS: replacement reported in %ld ms [%s]\n", elapsed, line);
+
+  /* a rewrite in several writes, then a second deploy to end the watch */
+  if (rewrite_file(watched) != 0)
+    goto cleanup;
+  if (read_line(pipefd[0], line, sizeof(line), TIMEOUT_MS) != 0 || strncmp(line, "event", 5) != 0 ||
+      !(atoi(line + 6) & PROGPATH_WATCH_MODIFIED)) {
+    fprintf(stderr, "FAIL: expected a modification event, got [%s]\n", line);
+    goto cleanup;
+  }
+  modified = 1;
+  if (copy_file(self, incoming, 0) != 0)
+    goto cleanup;
+  if (rename(incoming, watched) != 0) {
+    fprintf(stderr, "FAIL: rename(%s, %s) failed\n", incoming, watched);
+    goto cleanup;
+  }
+  while (1) {
+    if (read_line(pipefd[0], line, sizeof(line), TIMEOUT_MS) != 0 || strncmp(line, "event", 5) != 0) {
+      fprintf(stderr, "FAIL: no second replacement event [%s]\n", line);
+      goto cleanup;
+    }
+    if (atoi(line + 6) & PROGPATH_WATCH_REPLACED)
+      break;
+    modified++;
+  }
+  if (WATCH_EVENTS && modified != 1) {
+    fprintf(stderr, "FAIL: %d writes reported as %d modifications (expected 1)\n", REWRITES, modified);
+    goto cleanup;
+  }
+  printf("PASS: %d writes reported as %d modification%s\n", REWRITES, modified, modified == 1 ? "" : "s");
+
+  /* remove and slowly recreate, as 'rm app; cp new app' does */
+  if (stat(self, &st) != 0) {
+    fprintf(stderr, "FAIL: stat(%s) failed\n", self);
+    goto cleanup;
+  }
+  if (unlink(watched) != 0 || copy_file(self, watched, SLOW_GAP_MS) != 0) {
+    fprintf(stderr, "FAIL: could not recreate %s\n", watched);
+    goto cleanup;
+  }
+  while (1) {
+    if (read_line(pipefd[0], line, sizeof(line), TIMEOUT_MS) != 0 || strncmp(line, "event", 5) != 0) {
+      fprintf(stderr, "FAIL: no replacement event after recreating [%s]\n", line);
+      goto cleanup;
+    }
+    if (atoi(line + 6) & PROGPATH_WATCH_REPLACED)
+      break;
+    /* polling can miss the gap and see a reused inode rewritten */
+    if (!WATCH_EVENTS && (atoi(line + 6) & PROGPATH_WATCH_MODIFIED) &&
+        (copy_file(self, incoming, 0) != 0 || rename(incoming, watched) != 0))
+      goto cleanup;
+  }
+  size = strchr(line + 6, ' ') ? atol(strchr(line + 6, ' ') + 1) : -1L;
+  if (WATCH_EVENTS && size != (long)st.st_size) {
+    fprintf(stderr, "FAIL: replacement reported at %ld of %ld bytes [%s]\n", size, (long)st.st_size, line);
+    goto cleanup;
+  }
+  printf("PASS: recreated file reported at %ld of %ld bytes\n", size, (long)st.st_size);
+  ret = 0;
+
+cleanup:
+  close(pipefd[0]);
+  if (ret != 0)
+    kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+  if (ret == 0 && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+    fprintf(stderr, "FAIL: watcher exited abnormally\n");
+    ret = 1;
+  }
+  unlink(watched);
+  unlink(incoming);
+  rmdir(WATCH_DIR);
+  return ret;
+}
+
+#else
+
+int main(void) {
+  printf("SKIP: watch test requires fork(), exec(), and stat()\n");
+  return 0;
+}
+
+#endif